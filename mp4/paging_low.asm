@@ -29,4 +29,12 @@ _write_cr3:
 	mov eax, [ebp+8]
 	mov cr3, eax
 	pop ebp
-	retn
\ No newline at end of file
+	retn
+global _invlpg
+_invlpg:
+	push ebp
+	mov ebp, esp
+	mov eax, [ebp+8]
+	invlpg [eax]
+	pop ebp
+	retn
@@ -0,0 +1,131 @@
+#!/bin/bash
+#
+# Boot the benchmark kernel headless, and compare its results against the
+# stored baseline.
+#
+#   make bench
+#   ./bench.sh [-e qemu|bochs] [-t percent] [-u]
+#
+#   -e  Emulator to use (default: qemu). Bochs boots from the floppy image,
+#       so the kernel is copied onto it first (copykernel.sh, needs sudo);
+#       run copykernel.sh again afterwards to put back the regular kernel.
+#   -t  Flag workloads whose median is more than this many percent slower
+#       than in the baseline (default: 10).
+#   -u  Store the results as the new baseline.
+#
+# The results are kept in bench_results.csv, the baseline in
+# bench_baseline.csv, and everything the kernel wrote to port 0xE9 in
+# bench_output.txt. Exits with status 1 if a workload got slower, or is
+# missing.
+
+EMULATOR=qemu
+TOLERANCE=10
+UPDATE=0
+TIMEOUT=1800            # seconds
+
+OUTPUT=bench_output.txt
+RESULTS=bench_results.csv
+BASELINE=bench_baseline.csv
+DISK=bench_disk.img
+
+while getopts "e:t:u" opt; do
+    case $opt in
+        e) EMULATOR=$OPTARG ;;
+        t) TOLERANCE=$OPTARG ;;
+        u) UPDATE=1 ;;
+        *) sed -n '6,14p' "$0" >&2; exit 2 ;;
+    esac
+done
+
+KERNEL=kernel_bench.bin
+
+if [ ! -f $KERNEL ]; then
+    echo "$KERNEL not found; build the benchmark kernel with \"make bench\"" >&2
+    exit 2
+fi
+
+# A scratch disk with the geometry of c.img in bochsrc.bxrc, so that the
+# disk and file system workloads start from the same state every time.
+dd if=/dev/zero of=$DISK bs=512 count=$((306 * 4 * 17)) 2> /dev/null
+rm -f $OUTPUT
+
+case $EMULATOR in
+qemu)
+    # With -icount, the time stamp counter follows the instructions executed,
+    # so the cycle counts do not depend on the host or its load. The kernel
+    # writes to the isa-debug-exit port when it is done, and QEMU exits.
+    timeout $TIMEOUT qemu-system-i386 -m 32 -kernel $KERNEL \
+        -drive file=$DISK,format=raw,if=ide,index=0 \
+        -display none -monitor none -serial none \
+        -debugcon file:$OUTPUT \
+        -device isa-debug-exit,iobase=0xf4,iosize=0x04 \
+        -icount shift=0,sleep=off -no-reboot
+    ;;
+bochs)
+    ./copykernel.sh $KERNEL || exit 2
+
+    # Our bochsrc.bxrc, without display, with the scratch disk, and with a
+    # clock that follows the instructions rather than the wall clock.
+    sed -e "s|^\(ata0-master:.*path=\)\"[^\"]*\"|\1\"$DISK\"|" \
+        -e "s|^clock:.*|clock: sync=none, time0=946681200|" \
+        bochsrc.bxrc > bench.bxrc
+    echo "display_library: nogui" >> bench.bxrc
+
+    # Bochs does not stop by itself; wait for the kernel to finish.
+    bochs -q -f bench.bxrc > $OUTPUT 2>&1 &
+    BOCHS=$!
+    for (( t = 0; t < TIMEOUT; t++ )); do
+        grep -q "^# bench end" $OUTPUT && break
+        kill -0 $BOCHS 2> /dev/null || break
+        sleep 1
+    done
+    kill $BOCHS 2> /dev/null
+    wait $BOCHS 2> /dev/null
+    ;;
+*)
+    echo "unknown emulator \"$EMULATOR\"" >&2
+    exit 2
+    ;;
+esac
+
+if ! tr -d '\r' < $OUTPUT | grep -q "^# bench end"; then
+    echo "the benchmark kernel did not finish; see $OUTPUT" >&2
+    exit 2
+fi
+tr -d '\r' < $OUTPUT | grep "^result," > $RESULTS
+
+if [ $UPDATE = 1 ]; then
+    cp $RESULTS $BASELINE
+    echo "stored $(wc -l < $BASELINE) results as the new baseline in $BASELINE"
+    exit 0
+fi
+
+if [ ! -f $BASELINE ]; then
+    cat $RESULTS
+    echo "no baseline to compare with; store one with \"./bench.sh -u\""
+    exit 0
+fi
+
+# Lines are "result,<workload>,<ops>,<min>,<median>,<max>"; we compare the
+# median cycles per operation.
+awk -F, -v tolerance=$TOLERANCE '
+    NR == FNR { base[$2] = $5 / $3; next }
+    {
+        now = $5 / $3
+        seen[$2] = 1
+        if (!($2 in base) || base[$2] == 0) {
+            printf "%-20s %12.1f cycles/op   (new)\n", $2, now
+            next
+        }
+        change = 100 * (now - base[$2]) / base[$2]
+        note = ""
+        if (change > tolerance) { note = "   SLOWER"; slower++ }
+        else if (change < -tolerance) note = "   faster"
+        printf "%-20s %12.1f cycles/op %+7.1f%%%s\n", $2, now, change, note
+    }
+    END {
+        for (w in base) {
+            if (!(w in seen)) { printf "%-20s missing\n", w; slower++ }
+        }
+        exit (slower > 0)
+    }' $BASELINE $RESULTS
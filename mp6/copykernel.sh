@@ -1,5 +1,6 @@
 # Replace "/mnt/floppy" with the whatever directory is appropriate.
+# Copies kernel.bin, or the kernel image given as argument, as kernel.bin.
 sudo mount -o loop dev_kernel_grub.img /mnt/floppy
-sudo cp kernel.bin /mnt/floppy
+sudo cp ${1:-kernel.bin} /mnt/floppy/kernel.bin
 sleep 1s
 sudo umount /mnt/floppy